@@ -1,6 +1,14 @@
 #version 450
 layout(location = 0) out vec3 fragColor;
 
+// per-draw data, bound from the uniform ring with a dynamic offset
+layout(set = 0, binding = 0) uniform DrawUniforms { mat4 transform; }
+draw;
+
+// small per-draw data
+layout(push_constant) uniform DrawPushConstants { vec4 tint; }
+pc;
+
 vec2 positions[3] = {vec2(0.0, -0.5), vec2(0.5, 0.5), vec2(-0.5, 0.5)};
 
 vec3 colors[3] = {vec3(1.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0),
@@ -8,6 +16,6 @@ vec3 colors[3] = {vec3(1.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0),
 
 void main() {
 
-  gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-  fragColor = colors[gl_VertexIndex];
+  gl_Position = draw.transform * vec4(positions[gl_VertexIndex], 0.0, 1.0);
+  fragColor = colors[gl_VertexIndex] * pc.tint.rgb;
 }
\ No newline at end of file
@@ -90,6 +90,14 @@ static void ImGuiEndFrame() {
 
 using namespace VK_TOOLS;
 
+// matches DrawUniforms / DrawPushConstants in shader.vert
+struct DrawUniforms {
+  glm::mat4 transform;
+};
+struct DrawPushConstants {
+  glm::vec4 tint;
+};
+
 static void display_extensions(vk::PhysicalDevice &physicalDevice, vk::Instance &instance) {
   std::vector<std::string> extensions = get_physical_device_available_extensions(physicalDevice);
   ImGui::Begin("Extensions");
@@ -143,7 +151,7 @@ int main(int argc, char **argv) {
   bool has_ext = check_physical_device_extension_support(physical_device, {"VK_KHR_external_memory_win32"});
   std::cout << "has VK_KHR_external_memory_win32 : " << (has_ext ? "true" : "false") << std::endl;
 
-  vk::Device device = get_vulkan_device(vk_instance, physical_device);
+  vk::Device device = get_vulkan_device(vk_instance, physical_device, dldi);
   std::cout << "Device OK: " << device << std::endl;
 
   // init Dynamic loader ?
@@ -170,7 +178,41 @@ int main(int argc, char **argv) {
   std::cout << "RenderPass OK: " << renderPass << std::endl;
   vk::Framebuffer framebuffer = create_framebuffer(device, renderPass, imageView, 128, 128);
   std::cout << "Framebuffer OK: " << framebuffer << std::endl;
-  create_graphics_pipeline(device);
+
+  // 2 frames in flight, 64KB of per-draw data each
+  UniformRing uniformRing = create_uniform_ring(device, physical_device, 64 * 1024, 2, sizeof(DrawUniforms), vk::ShaderStageFlagBits::eVertex);
+  std::cout << "Uniform Ring OK: " << uniformRing.buffer << " (alignment " << uniformRing.alignment << ")" << std::endl;
+
+  vk::PipelineLayout pipelineLayout =
+      create_graphics_pipeline(device, {uniformRing.setLayout}, {push_constant_range<DrawPushConstants>(vk::ShaderStageFlagBits::eVertex)});
+  std::cout << "PipelineLayout OK: " << pipelineLayout << std::endl;
+
+  // a ring frame region is free again once the timeline reaches the value its command buffer signaled
+  SubmitBatcher submitBatcher = create_submit_batcher(device, physical_device);
+  std::cout << "Submit Batcher OK: " << submitBatcher.timeline << std::endl;
+
+  // one-time command buffer feeding the ring and push constants, there is no Vulkan draw in the frame loop yet
+  vk::CommandPoolCreateInfo commandPoolInfo{};
+  commandPoolInfo.queueFamilyIndex = get_graphics_queue_family_index(physical_device);
+  vk::CommandPool commandPool = device.createCommandPool(commandPoolInfo);
+
+  vk::CommandBufferAllocateInfo commandBufferInfo{};
+  commandBufferInfo.commandPool = commandPool;
+  commandBufferInfo.level = vk::CommandBufferLevel::ePrimary;
+  commandBufferInfo.commandBufferCount = 1;
+  vk::CommandBuffer commandBuffer = device.allocateCommandBuffers(commandBufferInfo)[0];
+
+  uniform_ring_begin_frame(uniformRing, 0);
+  UniformAllocation drawUniforms = uniform_ring_push(uniformRing, DrawUniforms{glm::mat4(1.0f)});
+
+  commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+  uniform_ring_bind(commandBuffer, pipelineLayout, 0, uniformRing, drawUniforms);
+  push_constants(commandBuffer, pipelineLayout, vk::ShaderStageFlagBits::eVertex, DrawPushConstants{glm::vec4(1.0f)});
+  commandBuffer.end();
+
+  uint64_t ringFrameValue = submit_batcher_enqueue(submitBatcher, commandBuffer);
+  submit_batcher_flush(submitBatcher, dldi);
+  std::cout << "Uniform Ring frame submitted, timeline value : " << ringFrameValue << std::endl;
 
   std::vector<Vertex> vertices = {
       {{0.0f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}}, // Red vertex
@@ -235,6 +277,12 @@ int main(int argc, char **argv) {
     glfwPollEvents();
   }
 
+  submit_batcher_wait(device, submitBatcher, submit_batcher_flush(submitBatcher, dldi), dldi);
+  destroy_submit_batcher(device, submitBatcher);
+  device.destroyCommandPool(commandPool);
+  destroy_uniform_ring(device, uniformRing);
+  device.destroyPipelineLayout(pipelineLayout);
+
   glfwDestroyWindow(window);
   glfwTerminate();
 
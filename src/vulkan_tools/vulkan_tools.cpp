@@ -70,20 +70,23 @@ vk::PhysicalDevice get_vulkan_physical_device(vk::Instance &instance) {
   return physicalDevice;
 }
 
-vk::Device get_vulkan_device(vk::Instance &instance, vk::PhysicalDevice &physicalDevice) {
-  // Get queue family supporting graphics
+uint32_t get_graphics_queue_family_index(vk::PhysicalDevice &physicalDevice) {
   uint32_t queueFamilyIndex = 0;
   std::vector<vk::QueueFamilyProperties> queueFamilyProps = physicalDevice.getQueueFamilyProperties();
 
   for (uint32_t i = 0; i < queueFamilyProps.size(); ++i) {
-    if (queueFamilyProps.size() > 0) {
-
-      if (queueFamilyProps[i].queueFlags & vk::QueueFlagBits::eGraphics) {
-        queueFamilyIndex = i;
-        break;
-      }
+    if (queueFamilyProps[i].queueFlags & vk::QueueFlagBits::eGraphics) {
+      queueFamilyIndex = i;
+      break;
     }
   }
+  return queueFamilyIndex;
+}
+
+vk::Device get_vulkan_device(vk::Instance &instance, vk::PhysicalDevice &physicalDevice, const vk::DispatchLoaderDynamic &dldi) {
+  // Get queue family supporting graphics
+  uint32_t queueFamilyIndex = get_graphics_queue_family_index(physicalDevice);
+
   // Create logical device
   vk::Device device;
   vk::DeviceQueueCreateInfo queueCreateInfo = {};
@@ -92,13 +95,38 @@ vk::Device get_vulkan_device(vk::Instance &instance, vk::PhysicalDevice &physica
   float queuePriority = 1.0f;
   queueCreateInfo.pQueuePriorities = &queuePriority;
 
+  const char *deviceExtensions[] = {VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME, VK_KHR_EXTERNAL_MEMORY_WIN32_EXTENSION_NAME,
+                                    VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME};
+  std::vector<std::string> availableExtensions = get_physical_device_available_extensions(physicalDevice);
+  for (const char *extension : deviceExtensions) {
+    if (std::find(availableExtensions.begin(), availableExtensions.end(), extension) == availableExtensions.end()) {
+      throw std::runtime_error(std::string("device extension not supported : ") + extension);
+    }
+  }
+
+  // timeline semaphores + synchronization2 for the submit batcher
+  vk::PhysicalDeviceSynchronization2FeaturesKHR synchronization2Features{};
+  vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures{};
+  timelineFeatures.pNext = &synchronization2Features;
+
+  // the instance is 1.0, query through VK_KHR_get_physical_device_properties2
+  vk::PhysicalDeviceFeatures2 features2{};
+  features2.pNext = &timelineFeatures;
+  physicalDevice.getFeatures2KHR(&features2, dldi);
+
+  if (!timelineFeatures.timelineSemaphore || !synchronization2Features.synchronization2) {
+    throw std::runtime_error("timeline semaphores or synchronization2 not supported by the device!");
+  }
+
   vk::DeviceCreateInfo deviceCreateInfo = {};
   deviceCreateInfo.queueCreateInfoCount = 1;
   deviceCreateInfo.pQueueCreateInfos = &queueCreateInfo;
-  const char *deviceExtensions[] = {VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME, VK_KHR_EXTERNAL_MEMORY_WIN32_EXTENSION_NAME};
-  deviceCreateInfo.enabledExtensionCount = 2;
+  deviceCreateInfo.enabledExtensionCount = 4;
   deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions;
-  physicalDevice.createDevice(&deviceCreateInfo, nullptr, &device);
+  deviceCreateInfo.pNext = &timelineFeatures;
+  if (physicalDevice.createDevice(&deviceCreateInfo, nullptr, &device) != vk::Result::eSuccess) {
+    throw std::runtime_error("failed to create logical device!");
+  }
 
   return device;
 }
@@ -265,7 +293,8 @@ vk::ShaderModule create_shader_module(vk::Device &device, const std::vector<char
   return shaderModule;
 }
 
-vk::PipelineLayout create_graphics_pipeline(vk::Device &device) {
+vk::PipelineLayout create_graphics_pipeline(vk::Device &device, const std::vector<vk::DescriptorSetLayout> &setLayouts,
+                                            const std::vector<vk::PushConstantRange> &pushConstantRanges) {
   auto vertShaderCode = read_file("./compiled_shaders/shader__vert.spv");
   auto fragShaderCode = read_file("./compiled_shaders/shader__frag.spv");
 
@@ -288,10 +317,10 @@ vk::PipelineLayout create_graphics_pipeline(vk::Device &device) {
   vk::PipelineLayout pipelineLayout;
 
   vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
-  pipelineLayoutInfo.setLayoutCount = 0;            // Optional
-  pipelineLayoutInfo.pSetLayouts = nullptr;         // Optional
-  pipelineLayoutInfo.pushConstantRangeCount = 0;    // Optional
-  pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+  pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+  pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+  pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+  pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
 
   if (device.createPipelineLayout(&pipelineLayoutInfo, nullptr, &pipelineLayout) != vk::Result::eSuccess) {
     throw std::runtime_error("failed to create pipeline layout!");
@@ -345,6 +374,284 @@ vk::Buffer create_vertex_buffer(vk::Device &device, const std::vector<Vertex> &v
 
   return vertexBuffer;
 }
+
+static vk::DeviceSize align_up(vk::DeviceSize value, vk::DeviceSize alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+UniformRing create_uniform_ring(vk::Device &device, vk::PhysicalDevice &physicalDevice, vk::DeviceSize frameSize, uint32_t frameCount,
+                                vk::DeviceSize bindingRange, vk::ShaderStageFlags stages, vk::BufferUsageFlags usage) {
+  UniformRing ring{};
+  vk::PhysicalDeviceLimits limits = physicalDevice.getProperties().limits;
+
+  bool isStorage = static_cast<bool>(usage & vk::BufferUsageFlagBits::eStorageBuffer);
+  ring.descriptorType = isStorage ? vk::DescriptorType::eStorageBufferDynamic : vk::DescriptorType::eUniformBufferDynamic;
+  ring.alignment = isStorage ? limits.minStorageBufferOffsetAlignment : limits.minUniformBufferOffsetAlignment;
+
+  vk::DeviceSize maxRange = isStorage ? limits.maxStorageBufferRange : limits.maxUniformBufferRange;
+  if (bindingRange == 0 || bindingRange > maxRange || bindingRange > frameSize) {
+    throw std::runtime_error("invalid uniform ring binding range!");
+  }
+
+  if (frameCount == 0) {
+    throw std::runtime_error("uniform ring needs at least one frame!");
+  }
+
+  ring.frameSize = align_up(frameSize, ring.alignment);
+  // dynamic offsets are 32 bits
+  if (ring.frameSize > UINT32_MAX / frameCount) {
+    throw std::runtime_error("uniform ring too large for 32 bit dynamic offsets!");
+  }
+  ring.frameCount = frameCount;
+  ring.bindingRange = bindingRange;
+
+  // pad the tail so the last allocation of the last frame can still be bound with the full range
+  vk::BufferCreateInfo bufferInfo{};
+  bufferInfo.size = ring.frameSize * frameCount + bindingRange;
+  bufferInfo.usage = usage;
+  bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+  ring.buffer = device.createBuffer(bufferInfo);
+
+  vk::MemoryRequirements memRequirements = device.getBufferMemoryRequirements(ring.buffer);
+  vk::MemoryAllocateInfo allocInfo{};
+  allocInfo.allocationSize = memRequirements.size;
+  allocInfo.memoryTypeIndex = findMemoryType(physicalDevice, memRequirements.memoryTypeBits,
+                                             vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+  ring.memory = device.allocateMemory(allocInfo);
+  device.bindBufferMemory(ring.buffer, ring.memory, 0);
+
+  // persistently mapped, coherent memory needs no flush
+  ring.mapped = static_cast<uint8_t *>(device.mapMemory(ring.memory, 0, VK_WHOLE_SIZE));
+
+  vk::DescriptorSetLayoutBinding binding{};
+  binding.binding = 0;
+  binding.descriptorType = ring.descriptorType;
+  binding.descriptorCount = 1;
+  binding.stageFlags = stages;
+
+  vk::DescriptorSetLayoutCreateInfo layoutInfo{};
+  layoutInfo.bindingCount = 1;
+  layoutInfo.pBindings = &binding;
+  ring.setLayout = device.createDescriptorSetLayout(layoutInfo);
+
+  vk::DescriptorPoolSize poolSize{};
+  poolSize.type = ring.descriptorType;
+  poolSize.descriptorCount = 1;
+
+  vk::DescriptorPoolCreateInfo poolInfo{};
+  poolInfo.maxSets = 1;
+  poolInfo.poolSizeCount = 1;
+  poolInfo.pPoolSizes = &poolSize;
+  ring.descriptorPool = device.createDescriptorPool(poolInfo);
+
+  vk::DescriptorSetAllocateInfo setInfo{};
+  setInfo.descriptorPool = ring.descriptorPool;
+  setInfo.descriptorSetCount = 1;
+  setInfo.pSetLayouts = &ring.setLayout;
+  ring.descriptorSet = device.allocateDescriptorSets(setInfo)[0];
+
+  // a single descriptor covers the whole ring, draws only change the dynamic offset
+  vk::DescriptorBufferInfo bufferDescriptor{};
+  bufferDescriptor.buffer = ring.buffer;
+  bufferDescriptor.offset = 0;
+  bufferDescriptor.range = bindingRange;
+
+  vk::WriteDescriptorSet write{};
+  write.dstSet = ring.descriptorSet;
+  write.dstBinding = 0;
+  write.descriptorCount = 1;
+  write.descriptorType = ring.descriptorType;
+  write.pBufferInfo = &bufferDescriptor;
+  device.updateDescriptorSets(write, nullptr);
+
+  return ring;
+}
+
+void destroy_uniform_ring(vk::Device &device, UniformRing &ring) {
+  device.destroyDescriptorPool(ring.descriptorPool);
+  device.destroyDescriptorSetLayout(ring.setLayout);
+  device.unmapMemory(ring.memory);
+  device.destroyBuffer(ring.buffer);
+  device.freeMemory(ring.memory);
+  ring = UniformRing{};
+}
+
+void uniform_ring_begin_frame(UniformRing &ring, uint32_t frameIndex) {
+  ring.frameIndex = frameIndex % ring.frameCount;
+  ring.head = 0;
+}
+
+UniformAllocation uniform_ring_allocate(UniformRing &ring, vk::DeviceSize size) {
+  if (size > ring.bindingRange) {
+    throw std::runtime_error("uniform allocation larger than the ring binding range!");
+  }
+
+  vk::DeviceSize offset = align_up(ring.head, ring.alignment);
+  if (offset + size > ring.frameSize) {
+    throw std::runtime_error("uniform ring frame exhausted!");
+  }
+  ring.head = offset + size;
+
+  vk::DeviceSize absolute = ring.frameSize * ring.frameIndex + offset;
+
+  UniformAllocation allocation{};
+  allocation.data = ring.mapped + absolute;
+  allocation.dynamicOffset = static_cast<uint32_t>(absolute);
+  allocation.size = size;
+  return allocation;
+}
+
+void uniform_ring_bind(vk::CommandBuffer &commandBuffer, vk::PipelineLayout &layout, uint32_t setIndex, const UniformRing &ring,
+                       const UniformAllocation &allocation, vk::PipelineBindPoint bindPoint) {
+  if (allocation.size > ring.bindingRange) {
+    throw std::runtime_error("uniform allocation does not fit the ring binding range!");
+  }
+  commandBuffer.bindDescriptorSets(bindPoint, layout, setIndex, ring.descriptorSet, allocation.dynamicOffset);
+}
+
+SubmitBatcher create_submit_batcher(vk::Device &device, vk::PhysicalDevice &physicalDevice) {
+  SubmitBatcher batcher{};
+  batcher.queue = device.getQueue(get_graphics_queue_family_index(physicalDevice), 0);
+
+  vk::SemaphoreTypeCreateInfoKHR typeInfo{};
+  typeInfo.semaphoreType = vk::SemaphoreType::eTimeline;
+  typeInfo.initialValue = 0;
+
+  vk::SemaphoreCreateInfo semaphoreInfo{};
+  semaphoreInfo.pNext = &typeInfo;
+  batcher.timeline = device.createSemaphore(semaphoreInfo);
+
+  return batcher;
+}
+
+void destroy_submit_batcher(vk::Device &device, SubmitBatcher &batcher) {
+  device.destroySemaphore(batcher.timeline);
+  batcher = SubmitBatcher{};
+}
+
+uint64_t submit_batcher_enqueue(SubmitBatcher &batcher, vk::CommandBuffer commandBuffer, uint64_t waitValue, vk::PipelineStageFlags2KHR waitStages) {
+  if (waitValue > batcher.nextValue) {
+    throw std::runtime_error("submit batcher wait on a timeline value that was never handed out!");
+  }
+
+  SubmitBatcher::Entry entry{};
+  entry.commandBuffer = commandBuffer;
+  entry.waitValue = waitValue;
+  entry.waitStages = waitStages;
+  entry.signalValue = ++batcher.nextValue;
+  batcher.pending.push_back(entry);
+
+  return entry.signalValue;
+}
+
+uint64_t submit_batcher_flush(SubmitBatcher &batcher, const vk::DispatchLoaderDynamic &dldi) {
+  if (batcher.pending.empty()) {
+    return batcher.submittedValue;
+  }
+
+  struct Batch {
+    size_t firstCommand;
+    uint32_t commandCount;
+    uint64_t waitValue;
+    vk::PipelineStageFlags2KHR waitStages;
+    uint64_t signalValue;
+  };
+
+  std::vector<vk::CommandBufferSubmitInfoKHR> commandInfos;
+  std::vector<Batch> batches;
+  commandInfos.reserve(batcher.pending.size());
+
+  // consecutive entries share one VkSubmitInfo2 as long as the open batch already waits for what they need.
+  // A wait on a value signaled inside the open batch, or a stronger wait than the batch has, starts a new one :
+  // the former because a batch only signals at its end, the latter so earlier entries are not held back by it.
+  // Extra VkSubmitInfo2 are cheap, they all go out in the same vkQueueSubmit2.
+  for (const SubmitBatcher::Entry &entry : batcher.pending) {
+    uint64_t waitValue = entry.waitValue > batcher.completedValue ? entry.waitValue : 0;
+    vk::PipelineStageFlags2KHR waitStages = waitValue > 0 ? entry.waitStages : vk::PipelineStageFlags2KHR{};
+
+    bool needsNewBatch = batches.empty();
+    if (!needsNewBatch) {
+      const Batch &open = batches.back();
+      bool waitsInsideBatch = waitValue > open.signalValue - open.commandCount;
+      bool waitsLonger = waitValue > open.waitValue || (open.waitStages | waitStages) != open.waitStages;
+      needsNewBatch = waitsInsideBatch || waitsLonger;
+    }
+
+    if (needsNewBatch) {
+      Batch batch{};
+      batch.firstCommand = commandInfos.size();
+      batch.waitValue = waitValue;
+      batch.waitStages = waitStages;
+      batches.push_back(batch);
+    }
+
+    Batch &batch = batches.back();
+    batch.commandCount++;
+    batch.signalValue = entry.signalValue;
+
+    vk::CommandBufferSubmitInfoKHR commandInfo{};
+    commandInfo.commandBuffer = entry.commandBuffer;
+    commandInfos.push_back(commandInfo);
+  }
+
+  std::vector<vk::SemaphoreSubmitInfoKHR> waitInfos(batches.size());
+  std::vector<vk::SemaphoreSubmitInfoKHR> signalInfos(batches.size());
+  std::vector<vk::SubmitInfo2KHR> submitInfos(batches.size());
+
+  for (size_t i = 0; i < batches.size(); ++i) {
+    const Batch &batch = batches[i];
+
+    waitInfos[i].semaphore = batcher.timeline;
+    waitInfos[i].value = batch.waitValue;
+    waitInfos[i].stageMask = batch.waitStages;
+
+    signalInfos[i].semaphore = batcher.timeline;
+    signalInfos[i].value = batch.signalValue;
+    signalInfos[i].stageMask = vk::PipelineStageFlagBits2KHR::eAllCommands;
+
+    submitInfos[i].waitSemaphoreInfoCount = batch.waitValue > 0 ? 1 : 0;
+    submitInfos[i].pWaitSemaphoreInfos = &waitInfos[i];
+    submitInfos[i].commandBufferInfoCount = batch.commandCount;
+    submitInfos[i].pCommandBufferInfos = &commandInfos[batch.firstCommand];
+    submitInfos[i].signalSemaphoreInfoCount = 1;
+    submitInfos[i].pSignalSemaphoreInfos = &signalInfos[i];
+  }
+
+  batcher.queue.submit2KHR(submitInfos, nullptr, dldi);
+
+  batcher.submittedValue = batches.back().signalValue;
+  batcher.pending.clear();
+  return batcher.submittedValue;
+}
+
+uint64_t submit_batcher_completed_value(vk::Device &device, SubmitBatcher &batcher, const vk::DispatchLoaderDynamic &dldi) {
+  batcher.completedValue = device.getSemaphoreCounterValueKHR(batcher.timeline, dldi);
+  return batcher.completedValue;
+}
+
+bool submit_batcher_wait(vk::Device &device, SubmitBatcher &batcher, uint64_t value, const vk::DispatchLoaderDynamic &dldi, uint64_t timeout) {
+  if (value > batcher.nextValue) {
+    throw std::runtime_error("submit batcher wait on a timeline value that was never handed out!");
+  }
+  if (value <= batcher.completedValue) {
+    return true;
+  }
+  // the signal of a pending entry is not on the queue yet, nothing could complete the wait
+  if (value > batcher.submittedValue) {
+    submit_batcher_flush(batcher, dldi);
+  }
+
+  vk::SemaphoreWaitInfoKHR waitInfo{};
+  waitInfo.semaphoreCount = 1;
+  waitInfo.pSemaphores = &batcher.timeline;
+  waitInfo.pValues = &value;
+
+  if (device.waitSemaphoresKHR(waitInfo, timeout, dldi) != vk::Result::eSuccess) {
+    return false;
+  }
+  if (value > batcher.completedValue) {
+    batcher.completedValue = value;
+  }
+  return true;
+}
 } // namespace VK_TOOLS
 
 // iostream utils
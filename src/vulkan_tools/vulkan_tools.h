@@ -1,9 +1,11 @@
 #ifndef VULKAN_TOOLS_H
 #define VULKAN_TOOLS_H
 #pragma once
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <type_traits>
 #include <vector>
 
 #define WIN32_LEAN_AND_MEAN
@@ -36,7 +38,8 @@ vk::Instance create_vulkan_instance();
 
 vk::PhysicalDevice get_vulkan_physical_device(vk::Instance &instance);
 
-vk::Device get_vulkan_device(vk::Instance &instance, vk::PhysicalDevice &physicalDevice);
+uint32_t get_graphics_queue_family_index(vk::PhysicalDevice &physicalDevice);
+vk::Device get_vulkan_device(vk::Instance &instance, vk::PhysicalDevice &physicalDevice, const vk::DispatchLoaderDynamic &dldi);
 
 vk::Image create_image(vk::Device &device, uint32_t width, uint32_t height);
 void allocate_image(vk::Device &device, vk::Image &image);
@@ -50,7 +53,8 @@ vk::Framebuffer create_framebuffer(vk::Device &device, vk::RenderPass &renderPas
 // graphics pipeline
 std::vector<char> read_file(const std::string &filename);
 vk::ShaderModule create_shader_module(vk::Device &device, const std::vector<char> &code);
-vk::PipelineLayout create_graphics_pipeline(vk::Device &device);
+vk::PipelineLayout create_graphics_pipeline(vk::Device &device, const std::vector<vk::DescriptorSetLayout> &setLayouts = {},
+                                            const std::vector<vk::PushConstantRange> &pushConstantRanges = {});
 
 // extension utils
 std::vector<std::string> get_instance_available_extensions();
@@ -73,6 +77,101 @@ struct fixedFunctions {
 
 vk::Buffer create_vertex_buffer(vk::Device &device, const std::vector<Vertex> &vertices, std::vector<uint16_t> indices);
 
+// per-frame uniform ring
+// One persistently mapped buffer split in frameCount regions. Each frame hands out aligned sub-ranges
+// that are bound through a single dynamic descriptor, so per-draw data costs a memcpy and a dynamic offset.
+struct UniformRing {
+  vk::Buffer buffer;
+  vk::DeviceMemory memory;
+  uint8_t *mapped = nullptr;
+
+  vk::DescriptorType descriptorType = vk::DescriptorType::eUniformBufferDynamic;
+  vk::DescriptorSetLayout setLayout;
+  vk::DescriptorPool descriptorPool;
+  vk::DescriptorSet descriptorSet;
+
+  vk::DeviceSize alignment = 0;    // minUniformBufferOffsetAlignment (or storage alignment)
+  vk::DeviceSize frameSize = 0;    // bytes available per frame, multiple of alignment
+  vk::DeviceSize bindingRange = 0; // range seen by the shader at each dynamic offset
+  uint32_t frameCount = 0;
+  uint32_t frameIndex = 0;
+  vk::DeviceSize head = 0; // next free byte in the current frame region
+};
+
+struct UniformAllocation {
+  void *data = nullptr;
+  uint32_t dynamicOffset = 0;
+  vk::DeviceSize size = 0;
+};
+
+UniformRing create_uniform_ring(vk::Device &device, vk::PhysicalDevice &physicalDevice, vk::DeviceSize frameSize, uint32_t frameCount,
+                                vk::DeviceSize bindingRange, vk::ShaderStageFlags stages,
+                                vk::BufferUsageFlags usage = vk::BufferUsageFlagBits::eUniformBuffer);
+void destroy_uniform_ring(vk::Device &device, UniformRing &ring);
+
+// the GPU must be done with the region of frameIndex before it is reused
+void uniform_ring_begin_frame(UniformRing &ring, uint32_t frameIndex);
+UniformAllocation uniform_ring_allocate(UniformRing &ring, vk::DeviceSize size);
+void uniform_ring_bind(vk::CommandBuffer &commandBuffer, vk::PipelineLayout &layout, uint32_t setIndex, const UniformRing &ring,
+                       const UniformAllocation &allocation, vk::PipelineBindPoint bindPoint = vk::PipelineBindPoint::eGraphics);
+
+template <typename T> UniformAllocation uniform_ring_push(UniformRing &ring, const T &value) {
+  static_assert(std::is_trivially_copyable<T>::value, "uniform data must be trivially copyable");
+  UniformAllocation allocation = uniform_ring_allocate(ring, sizeof(T));
+  std::memcpy(allocation.data, &value, sizeof(T));
+  return allocation;
+}
+
+// push constants
+// 128 bytes is the minimum maxPushConstantsSize every implementation guarantees
+template <typename T, uint32_t Offset = 0> vk::PushConstantRange push_constant_range(vk::ShaderStageFlags stages) {
+  static_assert(sizeof(T) % 4 == 0, "push constant size must be a multiple of 4");
+  static_assert(Offset % 4 == 0, "push constant offset must be a multiple of 4");
+  static_assert(Offset + sizeof(T) <= 128, "push constant block exceeds the guaranteed 128 bytes");
+  return vk::PushConstantRange(stages, Offset, sizeof(T));
+}
+
+template <typename T, uint32_t Offset = 0>
+void push_constants(vk::CommandBuffer &commandBuffer, vk::PipelineLayout &layout, vk::ShaderStageFlags stages, const T &value) {
+  static_assert(std::is_trivially_copyable<T>::value, "push constant data must be trivially copyable");
+  static_assert(sizeof(T) % 4 == 0 && Offset % 4 == 0, "push constant size and offset must be multiples of 4");
+  static_assert(Offset + sizeof(T) <= 128, "push constant block exceeds the guaranteed 128 bytes");
+  commandBuffer.pushConstants(layout, stages, Offset, sizeof(T), &value);
+}
+
+// submission batcher
+// Command buffers from every subsystem are queued with the timeline value they wait on and get back the value
+// they signal. A flush groups them into VkSubmitInfo2 without delaying any entry behind a later wait, and issues a single
+// vkQueueSubmit2, one timeline semaphore replaces per-submit fences.
+// submit2KHR / timeline queries go through the dynamic loader, like getMemoryWin32HandleKHR.
+struct SubmitBatcher {
+  struct Entry {
+    vk::CommandBuffer commandBuffer;
+    uint64_t waitValue;
+    vk::PipelineStageFlags2KHR waitStages;
+    uint64_t signalValue;
+  };
+
+  vk::Queue queue;
+  vk::Semaphore timeline;
+  uint64_t nextValue = 0;      // last value handed out by submit_batcher_enqueue
+  uint64_t submittedValue = 0; // last value sent to the queue
+  uint64_t completedValue = 0; // last value known to be reached on the GPU
+  std::vector<Entry> pending;
+};
+
+SubmitBatcher create_submit_batcher(vk::Device &device, vk::PhysicalDevice &physicalDevice);
+void destroy_submit_batcher(vk::Device &device, SubmitBatcher &batcher);
+
+// waitValue = 0 means no dependency, returns the timeline value signaled once commandBuffer has executed
+uint64_t submit_batcher_enqueue(SubmitBatcher &batcher, vk::CommandBuffer commandBuffer, uint64_t waitValue = 0,
+                                vk::PipelineStageFlags2KHR waitStages = vk::PipelineStageFlagBits2KHR::eAllCommands);
+uint64_t submit_batcher_flush(SubmitBatcher &batcher, const vk::DispatchLoaderDynamic &dldi);
+uint64_t submit_batcher_completed_value(vk::Device &device, SubmitBatcher &batcher, const vk::DispatchLoaderDynamic &dldi);
+// flushes first when value is still pending
+bool submit_batcher_wait(vk::Device &device, SubmitBatcher &batcher, uint64_t value, const vk::DispatchLoaderDynamic &dldi,
+                         uint64_t timeout = UINT64_MAX);
+
 } // namespace VK_TOOLS
 
 #endif